@@ -0,0 +1,200 @@
+// 物理エンジン (case 5, 6, 10, 11) のホスト用ベンチマーク
+//   make -C host bench
+// 1. phys_bounce で跳ねる回数と、反発直後の速度と rest_vel との余裕を表示する (rest_vel の再調整用)
+// 2. physics_step 1tick と、case 5/6 の anim_update 1回 (メインループ1ms分) の処理時間を、
+//    物理エンジンに置き換える前の状態機械版 (legacy_update_5/6、下にそのまま写した) と比べる
+// 時間はホスト (x86 など) の値なので、新旧の相対比較にだけ使う。実機 (RV32EC 48MHz) での
+// 1フレームの処理時間は、デバッガから g_frame_cycles_max / g_transition_frame_cycles_max を読む。
+
+#include <stdio.h>
+#include <time.h>
+
+#include "host_wrap.h"
+#include "../main.c"
+#undef while
+#undef main
+
+#define BENCH_LOOPS 10000000
+
+int host_tick(void) { return 0; } // fw_main は呼ばない
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// --- 置き換える前の case 5/6 (calculate_duration による状態機械) ---
+typedef struct {
+    uint32_t last_anim_time;
+    uint8_t anim_index_top;
+    uint8_t anim_index_bottom;
+    uint8_t anim_dir;
+} LegacyState_t;
+
+__attribute__((noinline)) static uint8_t legacy_update_5(LegacyState_t* s, uint32_t current_time, uint8_t* leds)
+{
+    uint8_t current_led_count = 0;
+    uint32_t required_interval_c5 = 100;
+    const uint16_t fall_start_ms = 100, fall_end_ms = 20, blink_ms = 50, pause_ms = 1000;
+    const uint8_t top_bottom_index = 10, bottom_bottom_index = 9;
+    const uint8_t bounce1_offset = 4, bounce2_offset = 2, bounce3_offset = 1;
+
+    if (s->anim_dir <= 6) {
+        if (s->anim_index_top >= top_bottom_index && s->anim_index_top < 20) { leds[current_led_count++] = path[s->anim_index_top]; }
+        if (s->anim_index_bottom <= bottom_bottom_index && s->anim_index_bottom < 10) { leds[current_led_count++] = path[s->anim_index_bottom]; }
+    } else if (s->anim_dir == 7 || s->anim_dir == 9) {
+        leds[0] = path[top_bottom_index];
+        leds[1] = path[bottom_bottom_index];
+        current_led_count = 2;
+    }
+
+    switch (s->anim_dir) {
+        case 0: required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, 10, s->anim_index_bottom); break;
+        case 1: required_interval_c5 = calculate_duration(fall_end_ms, fall_start_ms, bounce1_offset + 1, bottom_bottom_index - s->anim_index_bottom); break;
+        case 2: required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, bounce1_offset + 1, s->anim_index_bottom - (bottom_bottom_index - bounce1_offset)); break;
+        case 3: required_interval_c5 = calculate_duration(fall_end_ms, fall_start_ms, bounce2_offset + 1, bottom_bottom_index - s->anim_index_bottom); break;
+        case 4: required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, bounce2_offset + 1, s->anim_index_bottom - (bottom_bottom_index - bounce2_offset)); break;
+        case 5: required_interval_c5 = calculate_duration(fall_end_ms, fall_start_ms, bounce3_offset + 1, bottom_bottom_index - s->anim_index_bottom); break;
+        case 6: required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, bounce3_offset + 1, s->anim_index_bottom - (bottom_bottom_index - bounce3_offset)); break;
+        case 7: case 8: case 9: case 10: required_interval_c5 = blink_ms; break;
+        case 11: default: required_interval_c5 = pause_ms; break;
+    }
+
+    if ((current_time - s->last_anim_time) >= required_interval_c5) {
+        switch (s->anim_dir) {
+            case 0: if (s->anim_index_bottom == bottom_bottom_index) s->anim_dir = 1; else { s->anim_index_top--; s->anim_index_bottom++; } break;
+            case 1: if (s->anim_index_bottom == (bottom_bottom_index - bounce1_offset)) s->anim_dir = 2; else { s->anim_index_top++; s->anim_index_bottom--; } break;
+            case 2: if (s->anim_index_bottom == bottom_bottom_index) s->anim_dir = 3; else { s->anim_index_top--; s->anim_index_bottom++; } break;
+            case 3: if (s->anim_index_bottom == (bottom_bottom_index - bounce2_offset)) s->anim_dir = 4; else { s->anim_index_top++; s->anim_index_bottom--; } break;
+            case 4: if (s->anim_index_bottom == bottom_bottom_index) s->anim_dir = 5; else { s->anim_index_top--; s->anim_index_bottom++; } break;
+            case 5: if (s->anim_index_bottom == (bottom_bottom_index - bounce3_offset)) s->anim_dir = 6; else { s->anim_index_top++; s->anim_index_bottom--; } break;
+            case 6: if (s->anim_index_bottom == bottom_bottom_index) s->anim_dir = 7; else { s->anim_index_top--; s->anim_index_bottom++; } break;
+            case 7: case 8: case 9: case 10: s->anim_dir++; break;
+            case 11: default: s->anim_index_top = 19; s->anim_index_bottom = 0; s->anim_dir = 0; break;
+        }
+        s->last_anim_time = current_time;
+    }
+    return current_led_count;
+}
+
+__attribute__((noinline)) static uint8_t legacy_update_6(LegacyState_t* s, uint32_t current_time, uint8_t* leds)
+{
+    const uint16_t swing_slow_ms = 200, swing_fast_ms = 10;
+    const uint8_t total_segment_steps = 5;
+
+    if (s->anim_index_bottom < 10) leds[0] = path[s->anim_index_bottom];
+    if (s->anim_index_top >= 10 && s->anim_index_top < 20) leds[1] = path[s->anim_index_top];
+
+    uint8_t current_segment_step = (s->anim_index_bottom < 5) ? s->anim_index_bottom : 9 - s->anim_index_bottom;
+    uint32_t required_interval_c6 = calculate_duration(swing_slow_ms, swing_fast_ms, total_segment_steps, current_segment_step);
+
+    if ((current_time - s->last_anim_time) >= required_interval_c6) {
+        s->last_anim_time = current_time;
+        if (s->anim_dir == 0) {
+            if (s->anim_index_bottom >= 9) { s->anim_dir = 1; s->anim_index_bottom--; s->anim_index_top--; }
+            else { s->anim_index_bottom++; s->anim_index_top++; }
+        } else {
+            if (s->anim_index_bottom == 0) { s->anim_dir = 0; s->anim_index_bottom++; s->anim_index_top++; }
+            else { s->anim_index_bottom--; s->anim_index_top--; }
+        }
+    }
+    return 2;
+}
+
+// --- 1. バウンドの回数と rest_vel の余裕 ---
+static void report_bounce(void)
+{
+    Particle_t pt;
+    physics_init(&pt, 0, 0);
+    printf("phys_bounce: rest_vel %.4f idx/tick\n", phys_bounce.rest_vel / (double)PHYS_ONE);
+
+    int bounces = 0;
+    for (int tick = 1; tick < 1000; tick++) {
+        int32_t vel_before = pt.vel;
+        uint8_t rested = physics_step(&phys_bounce, &pt);
+        if (rested) {
+            // 静止と判定された反発の速度 (反発係数を掛けた後) を計算し直す
+            int32_t speed = (vel_before + phys_bounce.gravity) * phys_bounce.restitution >> 8;
+            printf("  tick %3d: rest, would-be speed %.4f (%.0f%% below rest_vel)\n", tick,
+                   speed / (double)PHYS_ONE, 100.0 * (phys_bounce.rest_vel - speed) / phys_bounce.rest_vel);
+            break;
+        }
+        if (vel_before >= 0 && pt.vel < 0) {
+            bounces++;
+            printf("  tick %3d: bounce %d, speed %.4f (%.0f%% above rest_vel)\n", tick, bounces,
+                   -pt.vel / (double)PHYS_ONE, 100.0 * (-pt.vel - phys_bounce.rest_vel) / phys_bounce.rest_vel);
+        }
+    }
+    printf("  %d bounces\n\n", bounces);
+}
+
+// --- 2. 処理時間 (BENCH_REPEAT 回測って最小値を取り、他プロセスによる揺れを抑える) ---
+#define BENCH_REPEAT 7
+
+static volatile uint32_t bench_sink;
+
+static double time_physics_step(const PhysicsParams_t* params, uint8_t anim_mode)
+{
+    AnimState_t s;
+    anim_reset(anim_mode, &s, 0);
+    double t0 = now_ns();
+    for (int i = 0; i < BENCH_LOOPS; i++) {
+        if (physics_step(params, s.particles)) anim_reset(anim_mode, &s, 0);
+        bench_sink += s.particles[0].pos;
+    }
+    return (now_ns() - t0) / BENCH_LOOPS;
+}
+
+static double time_frame(uint8_t anim_mode, uint8_t legacy)
+{
+    AnimState_t s;
+    LegacyState_t legacy_state = { 0, (anim_mode == 5) ? 19 : 10, 0, 0 };
+    anim_reset(anim_mode, &s, 0);
+    double t0 = now_ns();
+    for (int t = 0; t < BENCH_LOOPS; t++) {
+        uint8_t leds[5] = {0};
+        if (!legacy) bench_sink += anim_update(anim_mode, &s, t, leds);
+        else if (anim_mode == 5) bench_sink += legacy_update_5(&legacy_state, t, leds);
+        else bench_sink += legacy_update_6(&legacy_state, t, leds);
+    }
+    return (now_ns() - t0) / BENCH_LOOPS;
+}
+
+static void bench_physics_step(const char* name, const PhysicsParams_t* params, uint8_t anim_mode)
+{
+    double best = 1e9;
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        double t = time_physics_step(params, anim_mode);
+        if (t < best) best = t;
+    }
+    printf("physics_step %-14s %5.1f ns/tick\n", name, best);
+}
+
+static void bench_frame(uint8_t anim_mode)
+{
+    double best_new = 1e9, best_legacy = 1e9;
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        double t = time_frame(anim_mode, 0);
+        if (t < best_new) best_new = t;
+        t = time_frame(anim_mode, 1);
+        if (t < best_legacy) best_legacy = t;
+    }
+    printf("case %d 1ms frame: physics %5.1f ns, legacy %5.1f ns\n", anim_mode, best_new, best_legacy);
+}
+
+int main(void)
+{
+    report_bounce();
+
+    bench_physics_step("phys_bounce", &phys_bounce, 5);
+    bench_physics_step("phys_pendulum", &phys_pendulum, 6);
+    bench_physics_step("phys_orbit", &phys_orbit, 10);
+    bench_physics_step("phys_collide", &phys_collide, 11);
+    printf("\n");
+
+    bench_frame(5);
+    bench_frame(6);
+    return 0;
+}
@@ -0,0 +1,68 @@
+// ホスト (PC) で main.c をビルドするための debug.h の代用品
+// CH32V003 SDK のうち main.c が使う型・レジスタ・関数だけを、何もしない/変数に置き換える最小限のスタブ。
+// 実機用のビルドでは MounRiver Studio が生成する本物の debug.h が使われる。
+
+#ifndef HOST_DEBUG_H
+#define HOST_DEBUG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint16_t u16;
+
+// --- レジスタ (ただの変数として持つ) ---
+typedef struct { volatile uint32_t CFGLR, BSHR; } GPIO_TypeDef;
+typedef struct { volatile uint32_t SR, CMP, CNT, CTLR; } SysTick_Type;
+
+extern GPIO_TypeDef host_gpioa, host_gpioc, host_gpiod;
+extern SysTick_Type host_systick;
+extern volatile int host_button; // PD1 の入力値 (0 = 押下、1 = 開放)
+
+#define GPIOA   (&host_gpioa)
+#define GPIOC   (&host_gpioc)
+#define GPIOD   (&host_gpiod)
+#define SysTick (&host_systick)
+
+#define GPIO_Pin_1 0x0002
+#define GPIO_Pin_2 0x0004
+#define GPIO_Pin_4 0x0010
+#define Bit_RESET  0
+#define SET        1
+#define ENABLE     1
+
+#define SystemCoreClock 48000000u
+
+// --- 初期化用の構造体と定数 (値は使われない) ---
+typedef struct { int NVIC_IRQChannel, NVIC_IRQChannelPreemptionPriority, NVIC_IRQChannelSubPriority, NVIC_IRQChannelCmd; } NVIC_InitTypeDef;
+typedef struct { int TIM_Period, TIM_Prescaler, TIM_CounterMode, TIM_RepetitionCounter; } TIM_TimeBaseInitTypeDef;
+typedef struct { int GPIO_Pin, GPIO_Mode, GPIO_Speed; } GPIO_InitTypeDef;
+
+#define TIM1                 0
+#define TIM_IT_Update        1
+#define TIM_CounterMode_Up   0
+#define TIM1_UP_IRQn         0
+#define SysTick_IRQn         0
+#define RCC_APB2Periph_TIM1  0
+#define RCC_APB2Periph_GPIOD 0
+#define RCC_APB2Periph_GPIOA 0
+#define RCC_APB2Periph_GPIOC 0
+#define GPIO_Mode_IPU        0
+#define NVIC_PriorityGroup_1 0
+
+// --- SDK 関数 (割り込みフラグは常に立っているものとして扱う) ---
+static inline int TIM_GetITStatus(int tim, int it) { (void)tim; (void)it; return SET; }
+static inline void TIM_ClearITPendingBit(int tim, int it) { (void)tim; (void)it; }
+static inline void TIM_TimeBaseInit(int tim, TIM_TimeBaseInitTypeDef* init) { (void)tim; (void)init; }
+static inline void TIM_ITConfig(int tim, int it, int state) { (void)tim; (void)it; (void)state; }
+static inline void TIM_Cmd(int tim, int state) { (void)tim; (void)state; }
+static inline void RCC_APB2PeriphClockCmd(int periph, int state) { (void)periph; (void)state; }
+static inline void NVIC_Init(NVIC_InitTypeDef* init) { (void)init; }
+static inline void NVIC_PriorityGroupConfig(int group) { (void)group; }
+static inline void NVIC_EnableIRQ(int irq) { (void)irq; }
+static inline void SystemCoreClockUpdate(void) {}
+static inline void Delay_Init(void) {}
+static inline void GPIO_Init(GPIO_TypeDef* gpio, GPIO_InitTypeDef* init) { (void)gpio; (void)init; }
+static inline int GPIO_ReadInputDataBit(GPIO_TypeDef* gpio, int pin) { (void)gpio; (void)pin; return host_button; }
+static inline void __WFI(void) {}
+
+#endif // HOST_DEBUG_H
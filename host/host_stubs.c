@@ -0,0 +1,7 @@
+// host/debug.h で宣言したレジスタ代わりの変数の実体
+
+#include "debug.h"
+
+GPIO_TypeDef host_gpioa, host_gpioc, host_gpiod;
+SysTick_Type host_systick = { .CMP = SystemCoreClock / 1000 - 1 };
+volatile int host_button = 1; // 開放 (プルアップ)
@@ -0,0 +1,28 @@
+// ホスト用のハーネスが #include "../main.c" の直前に読み込むヘッダ
+// (main.c 自体には手を入れずに、ハーネスから main.c の関数や変数を使えるようにする)
+
+#ifndef HOST_WRAP_H
+#define HOST_WRAP_H
+
+// main.c が読み込む標準ヘッダは、下の while の置き換えより先に読み込んでおく
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// main はハーネス側が持つので、ファームウェアの main は fw_main として呼ぶ
+#define main fw_main
+
+// WCH 独自の割り込み属性 interrupt("WCH-Interrupt-fast") はホストのコンパイラにないので消す
+#define interrupt(x)
+
+// メインループ while (1) の1周ごとに host_tick() を呼ぶ (ハーネスが時刻と割り込みを進める)
+// host_tick() が 0 を返すと fw_main から抜ける。ほかの while 文は条件をそのまま評価する。
+int host_tick(void);
+static inline int host_loop_cond(const char* cond, int value)
+{
+    return (cond[0] == '1' && cond[1] == '\0') ? host_tick() : value;
+}
+#define while(cond) while (host_loop_cond(#cond, (cond)))
+
+#endif // HOST_WRAP_H
@@ -0,0 +1,137 @@
+// タイムライン再生のホスト用検証ハーネス
+//   make -C host verify
+// main.c の fw_main (元の main) をそのまま動かし、1msごとに SysTick_Handler と TIM1_UP_IRQHandler
+// (SCAN_TICKS_PER_MS 回) を呼んで、スキャンtickごとに点灯するLEDを記録する。
+// 同じボタン操作で、タイムライン再生を毎ms止めた (常にCPUで描画する) 実行と比べ、
+// 表示が1tickも違わないことを確かめる。
+//   1. 各モードを60秒ずつ表示 (モード開始直後からの展開・周期途中からの再生開始)
+//   2. ランダムな間隔のボタン押下 (再生中・展開中・遷移中の押下を含む)
+
+#include <stdio.h>
+
+#include "host_wrap.h"
+#include "../main.c"
+#undef while
+#undef main
+
+#define MAX_PRESSES 400
+
+typedef struct {
+    uint8_t volume;
+    uint8_t leds[5];
+} ScanFrame_t;
+
+static uint32_t sim_end_ms;
+static const uint32_t* sim_press_ms;  // 押下開始時刻 (昇順)
+static const uint16_t* sim_press_len; // 押している時間 (ms)
+static uint16_t sim_press_count;
+static uint8_t sim_reference;         // 1: タイムライン再生を使わない (比較用)
+
+static ScanFrame_t* ref_trace;        // 比較用の実行で記録したスキャンtickごとの表示
+static uint32_t trace_len;
+static uint32_t mismatches, first_mismatch_ms;
+static uint32_t playback_ticks;
+
+// fw_main の while (1) の1周ごとに呼ばれる: 1ms分の割り込みを実行し、時刻を進める
+int host_tick(void)
+{
+    uint32_t now = g_systick_ms;
+    if (now >= sim_end_ms) return 0;
+
+    // ボタン入力
+    host_button = 1;
+    for (uint16_t i = 0; i < sim_press_count; i++) {
+        if (now >= sim_press_ms[i] && now < sim_press_ms[i] + sim_press_len[i]) host_button = 0;
+    }
+
+    if (sim_reference) timeline_active = 0;
+
+    // この1msのスキャン (メインループが時刻 now のフレームを描画した後)
+    for (uint32_t k = 0; k < SCAN_TICKS_PER_MS; k++) {
+        TIM1_UP_IRQHandler();
+        if (timeline_active && timeline_output) playback_ticks++;
+
+        ScanFrame_t f = { LED_volume, { 0 } };
+        for (uint8_t i = 0; i < LED_volume && i < 5; i++) f.leds[i] = leds_to_display[i];
+        if (sim_reference) {
+            ref_trace[trace_len] = f;
+        } else if (memcmp(&ref_trace[trace_len], &f, sizeof(f)) != 0) {
+            if (mismatches == 0) first_mismatch_ms = now;
+            mismatches++;
+        }
+        trace_len++;
+    }
+
+    SysTick_Handler();
+    return 1;
+}
+
+static void sim_reset(void)
+{
+    g_systick_ms = 0;
+    mode = 0;
+    memset((void*)leds_to_display, 0, sizeof(leds_to_display));
+    dynamic_drive_counter = 0;
+    LED_volume = 1;
+    timeline_active = 0;
+    timeline_output = 0;
+    timeline_pos = timeline_now = 0;
+    timeline_ticks_left = timeline_skip_ticks = 0;
+    g_timeline_build_ms_max = 0;
+    trace_len = 0;
+}
+
+static uint32_t run_case(const char* name, uint32_t end_ms, const uint32_t* press_ms, const uint16_t* press_len, uint16_t press_count)
+{
+    sim_end_ms = end_ms;
+    sim_press_ms = press_ms;
+    sim_press_len = press_len;
+    sim_press_count = press_count;
+    ref_trace = malloc(sizeof(ScanFrame_t) * SCAN_TICKS_PER_MS * end_ms);
+
+    sim_reference = 1;
+    sim_reset();
+    fw_main();
+
+    sim_reference = 0;
+    mismatches = 0;
+    playback_ticks = 0;
+    sim_reset();
+    fw_main();
+
+    printf("%s: %u s, %u presses, playback %.0f%% of scan ticks, build-to-play max %u ms, %u mismatched ticks",
+           name, (unsigned)(end_ms / 1000), press_count, 100.0 * playback_ticks / trace_len,
+           (unsigned)g_timeline_build_ms_max, (unsigned)mismatches);
+    if (mismatches) printf(" (first at %u ms)", (unsigned)first_mismatch_ms);
+    printf("\n");
+    free(ref_trace);
+    return mismatches;
+}
+
+int main(void)
+{
+    static uint32_t press_ms[MAX_PRESSES];
+    static uint16_t press_len[MAX_PRESSES];
+
+    // 1. 各モードを60秒ずつ
+    for (uint16_t i = 0; i < 12; i++) {
+        press_ms[i] = 60000 * (i + 1);
+        press_len[i] = 100;
+    }
+    uint32_t failed = run_case("each mode 60 s", 60000 * 13, press_ms, press_len, 12);
+
+    // 2. ランダムな押下 (遷移中 400ms 以内の押下を含む)
+    uint32_t seed = 12345, t = 500;
+    uint16_t n = 0;
+    while (n < MAX_PRESSES) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t r = (seed >> 16) & 0x7FFF;
+        press_ms[n] = t;
+        press_len[n] = 60 + (r & 0x7F);
+        t += press_len[n] + ((r & 3) == 0 ? 100 + (r >> 7) % 300 : 200 + (r >> 2) % 6000);
+        n++;
+    }
+    failed += run_case("random presses", t + 3000, press_ms, press_len, n);
+
+    return failed != 0;
+}
@@ -25,6 +25,125 @@ volatile uint8_t dynamic_drive_counter = 0;
 // TIM1ハンドラが参照する同時点灯数を制御する変数
 volatile uint8_t LED_volume = 1; // 初期値1
 
+// 物理的な反時計回りのLED番号の並び順
+const uint8_t path[20] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,  // index 0-9
+                          20,19,18,17,16,15,14,13,12, 11}; // index 10-19
+
+// 物理エンジンの粒子 (位置・速度とも Q16.16、単位は path インデックス)
+#define PHYS_ONE              65536 // Q16.16 の 1.0
+#define PHYSICS_TICK_MS       10    // 物理を進める固定tick (ms)
+#define PHYSICS_MAX_PARTICLES 2
+
+typedef struct {
+    int32_t pos; // 位置 (インデックス)
+    int32_t vel; // 速度 (インデックス/tick)
+} Particle_t;
+
+// 物理モードごとのパラメータ (Flashに置く)
+typedef struct {
+    int32_t gravity;      // 一定加速度 (Q16.16 /tick^2、正はインデックス増加方向)
+    int32_t spring_k;     // center への復元力係数 (Q0.16、0で無効)
+    int32_t center;       // 復元力の中心 (Q16.16)
+    int32_t lo, hi;       // 可動範囲 (Q16.16)
+    int32_t rest_vel;     // 壁での反発後にこの速度未満なら静止とみなす (Q16.16)
+    uint16_t restitution; // 反発係数 (Q0.8、256で完全弾性)
+    uint16_t damping;     // 1tickごとの速度保持率 (Q0.8、256で減衰なし)
+    uint8_t wrap;         // 1: lo..hi をリングとして周回 (壁なし)
+    uint8_t snap_turn;    // 1: 速度の向きが変わる折り返し点で、center から見て同じ側の壁に速度0で揃える
+    uint8_t collide;      // 1: 粒子同士の衝突を処理
+    uint8_t count;        // 粒子数 (PHYSICS_MAX_PARTICLES 以下)
+} PhysicsParams_t;
+
+// 各アニメーションで使用する状態変数 (モード切替時にリセット)
+// モード遷移中は旧モードと新モードの2組が同時に動くため、1組を小さく保つ (24バイト)
+typedef struct {
+    uint32_t last_anim_time;   // アニメーションステップ更新用
+    uint8_t anim_index;        // path配列のインデックス (0-19) や他の用途
+    uint8_t anim_step;         // case 0, 2 で使用
+    uint8_t anim_dir;          // アニメーションの方向/状態管理用
+    union {
+        uint8_t sparkle_leds[3];                       // ★ case 7 (スパークル) 用のLED配列 ★
+        Particle_t particles[PHYSICS_MAX_PARTICLES];   // case 5, 6, 10, 11 (物理エンジン) 用
+    };
+} AnimState_t;
+
+// モード遷移 (ボタン押下時に旧モードから新モードへ切り替える演出) の種類
+typedef enum {
+    TRANSITION_WIPE,      // path順に新モードへ置き換える
+    TRANSITION_DISSOLVE,  // ランダムな順に新モードへ置き換える
+    TRANSITION_CROSSFADE, // 新旧フレームを時分割してデューティで混ぜる
+    TRANSITION_TYPES
+} TransitionType_t;
+
+// 遷移中に旧モードのフレームをどこから取るか
+typedef enum {
+    TRANSITION_OUT_ANIM,     // 旧モードの状態を anim_update で進め続ける
+    TRANSITION_OUT_TIMELINE, // 旧モードはタイムライン再生中だったため、TIM1割り込みが進める timeline から読む
+    TRANSITION_OUT_HOLD,     // 遷移中に押されたため、その時点で表示していたフレームを静止画として使う
+} TransitionOut_t;
+
+// CH32V003 (RV32EC) には乗除算命令がないため、毎フレームの合成では割り算を使わない
+#define TRANSITION_STEP_MS        20  // 遷移の進み具合 (progress 0-20) を1つ進める間隔 (ms、遷移全体で400ms)
+#define TRANSITION_FADE_PERIOD_MS 16  // クロスフェードの時分割周期 (ms、剰余をマスクで取るため2のべき乗)
+
+// 1フレーム分の計算 (anim_update + 遷移合成) にかかったサイクル数 (48MHz)
+// デバッガから参照して、遷移中に増える処理時間を確認する
+volatile uint32_t g_frame_cycles_max = 0;            // 通常時の最大値
+volatile uint32_t g_transition_frame_cycles_max = 0; // 遷移中の最大値
+
+// --- タイムライン再生 ---
+// 周期的なモードは、遷移が終わった後に1周期分のフレームを (フレーム, 表示スキャンtick数) の
+// ランレングス表に展開し、TIM1割り込みが単独で再生する (メインループは次のボタン押下まで待機)
+// 展開はメインループが1周ごとに TIMELINE_BUILD_STEP_MS 分ずつ進め、その間もCPUで描画を続ける
+#define TIM1_PRESCALER         24    // TIM1 の分周比 (48MHz / 24 = 2MHz)
+#define TIM1_PERIOD            500   // TIM1 の更新周期のカウント数 (2MHz / 500 = 4kHz)
+// 1msあたりのスキャンtick数 (48MHz / 24 / 500 / 1000 = 4)。TIM1 の設定から導出する
+#define SCAN_TICKS_PER_MS      (SystemCoreClock / TIM1_PRESCALER / TIM1_PERIOD / 1000)
+#define TIMELINE_MAX_ENTRIES   40    // 展開できるフレーム数の上限 (RAM 8バイト/フレーム、最大は case 5 の32)
+#define TIMELINE_MAX_SEARCH_MS 5000  // 周期を探す最大時間 (これより長いモードはCPUで描画)
+#define TIMELINE_BUILD_STEP_MS 8     // メインループ1周で模擬実行する時間 (ms、描画を遅らせないよう小さく)
+
+typedef struct {
+    uint8_t leds[5];  // 表示するLED番号 (leds_to_display と同じ形式)
+    uint8_t count;    // 点灯数 (0-5)
+    uint16_t ticks;   // このフレームを表示するスキャンtick数
+} TimelineEntry_t;
+
+// 展開の進み具合
+typedef enum {
+    TIMELINE_BUILD_IDLE,    // 未着手 (遷移が終わったら展開を始める)
+    TIMELINE_BUILD_RUNNING, // メインループで少しずつ展開中
+    TIMELINE_BUILD_DONE,    // 展開できた (再生を始める)
+    TIMELINE_BUILD_FAILED   // 周期がない/長すぎる (次のボタン押下まではCPUで描画)
+} TimelineBuildState_t;
+
+// 展開中の状態 (メインループの1周ごとに timeline_build_step で少しずつ進める)
+typedef struct {
+    AnimState_t start;     // 展開開始時点の状態 (これと同じ状態に戻ったら1周期)
+    AnimState_t sim;       // 模擬実行中の状態
+    uint32_t start_time;   // start の時刻 (ms)
+    uint32_t elapsed_ms;   // start_time からの模擬実行時間 (ms)
+    uint16_t ticks_per_ms; // SCAN_TICKS_PER_MS (割り算を避けるため展開開始時に1回だけ計算)
+    uint8_t anim_mode;
+    uint8_t state;         // TimelineBuildState_t
+} TimelineBuilder_t;
+
+volatile TimelineEntry_t timeline[TIMELINE_MAX_ENTRIES];
+volatile uint8_t timeline_length = 0;      // 有効なフレーム数
+volatile uint8_t timeline_active = 0;      // 1: TIM1割り込みが timeline を進めている
+volatile uint8_t timeline_output = 0;      // 1: 進めたフレームを leds_to_display に書く (0: 遷移中でメインループが描画)
+volatile uint8_t timeline_pos = 0;         // 次に表示するフレーム
+volatile uint8_t timeline_now = 0;         // 次のスキャンtickで表示するフレーム (遷移中はメインループが旧モードとして読む)
+volatile uint16_t timeline_ticks_left = 0; // 表示中のフレームの残りtick数
+volatile uint16_t timeline_skip_ticks = 0; // 再生開始時、最初のフレームで飛ばすtick数 (周期の途中から始めるため)
+volatile uint32_t timeline_start = 0;      // 再生を始める時刻 (ms)
+uint32_t timeline_period_ms = 0;           // 1周期の長さ (ms)
+
+// デバッガ参照用: timeline_build_step 1回にかかった最大サイクル数 (48MHz) と、
+// 展開を始めてから再生を始めるまでの最大時間 (ms、この間もCPUで描画を続けている)
+volatile uint32_t g_timeline_step_cycles_max = 0;
+volatile uint32_t g_timeline_build_ms_max = 0;
+
 // --- LED制御関数 ---
 /**
  * @brief (高速版) 指定したピンを指定した状態に設定する
@@ -141,6 +260,735 @@ uint32_t calculate_duration(uint16_t start_ms, uint16_t end_ms, uint8_t total_st
     return (uint32_t)duration;
 }
 
+// --- 物理エンジン (固定小数点) ---
+// 位置・速度は Q16.16 (PHYS_ONE = path 1インデックス分)、時間は PHYSICS_TICK_MS 単位の固定tick。
+// 割り算・浮動小数点を使わず、係数はすべて乗算とシフトで適用する。
+
+// ★ 落下→バウンド (case 5): 0 (頂点) から 9 (底) へ落下し、3回跳ねて (頂点 4, 6, 7付近) 静止 ★
+// 落下 9インデックスを約 600ms (旧実装と同程度) で終えるよう g を選ぶ
+// 反発直後の速度は 0.223, 0.165, 0.123, (0.087) インデックス/tick と減るので、rest_vel は
+// 3回目と4回目の中間に置き、どちらにも約17%の余裕を持たせる (g や反発係数を変えたら host/bench_physics で確認)
+const PhysicsParams_t phys_bounce = {
+    .gravity = 328,                   // 約 0.005 インデックス/tick^2
+    .lo = 0, .hi = 9 * PHYS_ONE,
+    .rest_vel = PHYS_ONE * 105 / 1000, // 反発後の速度がこれ未満なら静止 (0.105)
+    .restitution = 190,               // 約 0.74 (跳ね返る高さが毎回約半分)
+    .damping = 256,
+    .count = 1,
+};
+
+// ★ 振り子 (case 6): 4.5 を中心とする単振動、片道約 1.05 秒 ★
+// 折り返し点で壁 (0 または 9) に速度0で揃えるため (snap_turn)、片道ごとに必ず同じ状態から振り始め、
+// 振幅の丸め誤差は積み上がらない。復元力は center に対して対称に丸めるので、0→9 と 9→0 は
+// 鏡映の関係で同じtick数になり、周期は片道の厳密に2倍になる (タイムライン展開で周期を見つけられる)
+const PhysicsParams_t phys_pendulum = {
+    .spring_k = 59,                 // (pi / 105tick)^2 * 65536
+    .center = 9 * PHYS_ONE / 2,
+    .lo = 0, .hi = 9 * PHYS_ONE,
+    .restitution = 0,               // 折り返す前に壁を越えた場合も、壁に速度0で止める
+    .damping = 256,
+    .snap_turn = 1,
+    .count = 1,
+};
+
+// ★ 軌道 (case 10): 20 LED のリングを逆向きに周回する2粒子 ★
+const PhysicsParams_t phys_orbit = {
+    .lo = 0, .hi = 20 * PHYS_ONE,
+    .damping = 256,
+    .wrap = 1,
+    .count = 2,
+};
+
+// ★ 衝突 (case 11): path[0]/path[19] の間を壁とし、2粒子が壁と互いに弾性衝突 ★
+const PhysicsParams_t phys_collide = {
+    .lo = 0, .hi = 19 * PHYS_ONE,
+    .restitution = 256,
+    .damping = 256,
+    .collide = 1,
+    .count = 2,
+};
+
+/**
+ * @brief 粒子の位置と速度を設定する (Q16.16)
+ */
+void physics_init(Particle_t* pt, int32_t pos, int32_t vel)
+{
+    pt->pos = pos;
+    pt->vel = vel;
+}
+
+/**
+ * @brief 粒子の位置を四捨五入して path インデックス (0-19) に変換する
+ */
+uint8_t physics_index(const Particle_t* pt)
+{
+    uint8_t index = (uint8_t)((pt->pos + PHYS_ONE / 2) >> 16);
+    return (index >= 20) ? index - 20 : index;
+}
+
+/*********************************************************************
+ * @fn      physics_step
+ * @brief   全粒子を1tick進めます (半陰的オイラー法: 速度→位置の順に更新)。
+ * @param   p - 物理パラメータ。
+ * @param   pt - 粒子配列 (p->count 個)。
+ * @return  壁で跳ね返った直後の速度が p->rest_vel 未満になり静止した粒子のビットマスク。
+ */
+uint8_t physics_step(const PhysicsParams_t* p, Particle_t* pt)
+{
+    uint8_t rested = 0;
+
+    for (uint8_t i = 0; i < p->count; i++) {
+        int32_t acc = p->gravity;
+        if (p->spring_k != 0) {
+            // 右シフトの切り捨てで片側に偏らないよう、変位の絶対値で四捨五入してから符号を戻す
+            int32_t offset = pt[i].pos - p->center;
+            int32_t force = (((offset >= 0) ? offset : -offset) * p->spring_k + (1 << 15)) >> 16;
+            acc -= (offset >= 0) ? force : -force;
+        }
+        int32_t prev_vel = pt[i].vel;
+        pt[i].vel += acc;
+        if (p->damping != 256) {
+            pt[i].vel = (pt[i].vel * p->damping) >> 8;
+        }
+        if (p->snap_turn && ((prev_vel > 0 && pt[i].vel <= 0) || (prev_vel < 0 && pt[i].vel >= 0))) {
+            // 折り返し点: center から見て同じ側の壁に速度0で置き直す
+            pt[i].pos = (pt[i].pos >= p->center) ? p->hi : p->lo;
+            pt[i].vel = 0;
+            continue;
+        }
+        pt[i].pos += pt[i].vel;
+
+        if (p->wrap) {
+            // リング: 範囲外に出たら反対側へ回り込む (1tickの移動量は範囲より小さい前提)
+            if (pt[i].pos >= p->hi) pt[i].pos -= p->hi - p->lo;
+            else if (pt[i].pos < p->lo) pt[i].pos += p->hi - p->lo;
+        } else if (pt[i].pos > p->hi || pt[i].pos < p->lo) {
+            // 壁: 位置を壁に戻し、速度を反転して反発係数を掛ける
+            pt[i].pos = (pt[i].pos > p->hi) ? p->hi : p->lo;
+            pt[i].vel = -((pt[i].vel * p->restitution) >> 8);
+            int32_t speed = (pt[i].vel >= 0) ? pt[i].vel : -pt[i].vel;
+            if (speed < p->rest_vel) {
+                pt[i].vel = 0;
+                rested |= 1 << i;
+            }
+        }
+    }
+
+    // 粒子同士の衝突 (粒子0が常に粒子1より lo 側にいる前提)
+    // 等質量の1次元衝突: 重心速度を保ったまま相対速度を反転し、反発係数を掛ける
+    if (p->collide && p->count >= 2 && pt[0].pos > pt[1].pos) {
+        int32_t v_center = (pt[0].vel + pt[1].vel) >> 1;
+        int32_t v_half = ((pt[0].vel - pt[1].vel) * p->restitution) >> 9;
+        pt[0].vel = v_center - v_half;
+        pt[1].vel = v_center + v_half;
+        pt[0].pos = pt[1].pos = (pt[0].pos + pt[1].pos) >> 1;
+    }
+
+    return rested;
+}
+
+// --- アニメーション関数 ---
+
+/**
+ * @brief leds[0..count) にまだなければ led_num を追加し、新しい点灯数を返す
+ * @note 同じLEDを2回登録すると、そのLEDだけスキャンのデューティが倍になり他が暗くなるため。
+ */
+uint8_t leds_add_unique(uint8_t* leds, uint8_t count, uint8_t led_num)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (leds[i] == led_num) return count;
+    }
+    if (count < 5) leds[count++] = led_num;
+    return count;
+}
+
+/**
+ * @brief 指定モードの状態変数を初期値に戻す (モード切替時に呼ぶ)
+ */
+void anim_reset(uint8_t anim_mode, AnimState_t* s, uint32_t current_time)
+{
+    s->anim_index = 0;        // デフォルト開始インデックス
+    s->anim_step = 1;         // デフォルト開始ステップ
+    s->anim_dir = 0;          // デフォルト方向/状態
+
+    if (anim_mode == 5) { // case 5 (同時落下バウンド): 頂点に静止した状態から落下
+        physics_init(&s->particles[0], 0, 0);
+    }
+    else if (anim_mode == 6) { // case 6 (振り子): 端 (path[0] / path[10]) から振り始める
+        physics_init(&s->particles[0], 0, 0);
+    }
+    else if (anim_mode == 7) { // ★ case 7 (スパークル) 用の初期化 ★
+        // 最初のフレームを生成しておく
+        s->sparkle_leds[0] = path[rand() % 20];
+        s->sparkle_leds[1] = path[rand() % 20];
+        s->sparkle_leds[2] = path[rand() % 20];
+    }
+    else if (anim_mode == 8) { // ★ case 8 (コメット) 用 ★
+        s->anim_index = 0; // デフォルトだが明示
+    }
+    else if (anim_mode == 10) { // case 10 (軌道): 反対側から逆向き・異なる速度で周回
+        physics_init(&s->particles[0], 0, PHYS_ONE / 5);          // 50ms/LED
+        physics_init(&s->particles[1], 10 * PHYS_ONE, -PHYS_ONE / 8); // 80ms/LED
+    }
+    else if (anim_mode == 11) { // case 11 (衝突): 速い粒子0と遅い粒子1が向かい合って動く
+        physics_init(&s->particles[0], 2 * PHYS_ONE, PHYS_ONE / 4);
+        physics_init(&s->particles[1], 15 * PHYS_ONE, -PHYS_ONE / 10);
+    }
+
+    s->last_anim_time = current_time; // アニメーション時間もリセット
+}
+
+/*********************************************************************
+ * @fn      anim_update
+ * @brief   指定モードのアニメーションを1ループ分進め、表示するLEDを書き出します。
+ * @param   anim_mode - 対象のモード番号 (現在のモードとは限らない)。
+ * @param   s - そのモードの状態変数 (遷移中は新旧2つのモードが別々に持つ)。
+ * @param   current_time - 現在時刻 (ms)。
+ * @param   leds - 表示するLED番号の書き込み先 (5要素、呼び出し側で0クリア済み)。
+ * @return  点灯するLEDの数 (0-5)。
+ */
+uint8_t anim_update(uint8_t anim_mode, AnimState_t* s, uint32_t current_time, uint8_t* leds)
+{
+    uint8_t current_led_count = 0;
+
+
+    switch(anim_mode)
+    {
+        case 0: // 向かい合わせ
+        {
+            uint32_t required_interval = 50;
+            // 1. 表示設定 (毎回実行)
+            current_led_count = 2;
+            uint8_t current_led_num = (s->anim_step >= 1 && s->anim_step <= 10) ? s->anim_step : 1;
+            leds[0] = current_led_num;
+            leds[1] = current_led_num + 10;
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval) {
+                s->anim_step++;
+                if(s->anim_step > 10) s->anim_step = 1;
+                s->last_anim_time = current_time;
+            }
+        }
+            break;
+
+        case 1: // path配列を1周 (単一LED)
+        {
+            uint32_t required_interval = 20;
+            // 1. 表示設定 (毎回実行)
+            current_led_count = 1;
+            if (s->anim_index < 20) { leds[0] = path[s->anim_index]; }
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval) {
+                s->anim_index++;
+                if(s->anim_index >= 20) s->anim_index = 0;
+                s->last_anim_time = current_time;
+            }
+        }
+            break;
+
+        case 2: // バウンス (1-5往復、4LED)
+        {
+            uint32_t required_interval_c2;
+            if (s->anim_dir == 2) { required_interval_c2 = 1000; } else { required_interval_c2 = 75; }
+
+            // 1. 表示設定 (毎回実行)
+            if (s->anim_step != 0 && s->anim_dir != 2) { // Pause中でなければ
+                leds[0] = s->anim_step; // s->anim_step は 1-5
+                leds[1] = 11 - s->anim_step;
+                leds[2] = 10 + s->anim_step;
+                leds[3] = 21 - s->anim_step;
+                current_led_count = 4;
+            } else {
+                current_led_count = 0;
+            }
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval_c2) {
+                if (s->anim_dir == 0) { s->anim_step++; if (s->anim_step > 5) { s->anim_step = 4; s->anim_dir = 1; } }
+                else if (s->anim_dir == 1) { s->anim_step--; if (s->anim_step < 1) { s->anim_step = 0; s->anim_dir = 2; } }
+                else { s->anim_step = 1; s->anim_dir = 0; }
+                s->last_anim_time = current_time;
+            }
+        }
+            break;
+
+        case 3: // path配列を1周 (3LED等間隔)
+        {
+            uint32_t required_interval = 50;
+            // 1. 表示設定 (毎回実行)
+            current_led_count = 3;
+            if (s->anim_index < 20) {
+                uint8_t index1 = s->anim_index;
+                uint8_t index2 = (s->anim_index + 7) % 20;
+                uint8_t index3 = (s->anim_index + 14) % 20;
+                leds[0] = path[index1];
+                leds[1] = path[index2];
+                leds[2] = path[index3];
+                leds[3] = 0; //明示しないとゴーストが出る
+            }
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval) {
+                s->anim_index++;
+                if (s->anim_index >= 20) s->anim_index = 0;
+                s->last_anim_time = current_time;
+            }
+        }
+            break;
+
+        
+        case 4: // 2段階加速アニメーション
+        {
+            uint32_t required_interval_c4;
+            const uint8_t segment_steps = 10;
+            const uint16_t start_duration_c4 = 100;
+            const uint16_t end_duration_c4 = 5;
+
+            // 1. 表示設定 (毎回実行)
+            if ((s->anim_dir == 0 || s->anim_dir == 2) && s->anim_index < 20) { // Moving
+                leds[0] = path[s->anim_index];
+                current_led_count = 1;
+            } else { // Paused
+                current_led_count = 0;
+            }
+
+            // 2. 時間経過チェックと状態更新
+            switch(s->anim_dir) {
+                case 0: required_interval_c4 = calculate_duration(start_duration_c4, end_duration_c4, segment_steps, s->anim_index); break;
+                case 2: required_interval_c4 = calculate_duration(start_duration_c4, end_duration_c4, segment_steps, s->anim_index - 10); break;
+                case 1: case 3: default: required_interval_c4 = 1000; break;
+            }
+
+            if((current_time - s->last_anim_time) >= required_interval_c4) {
+                switch(s->anim_dir) {
+                    case 0: if (s->anim_index == (segment_steps - 1)) { s->anim_dir = 1; } else { s->anim_index++; } break;
+                    case 1: s->anim_index = 10; s->anim_dir = 2; break;
+                    case 2: if (s->anim_index == (segment_steps * 2 - 1)) { s->anim_dir = 3; } else { s->anim_index++; } break;
+                    case 3: default: s->anim_index = 0; s->anim_dir = 0; break;
+                }
+                s->last_anim_time = current_time;
+            }
+        }
+            break; // case 4 の終了
+
+        case 5: // ★ 上下同時落下→バウンド (物理エンジン版) ★
+        {
+            const uint16_t blink_ms = 50;
+            const uint16_t pause_ms = 1000;
+
+            // 粒子の位置 (0=頂点, 9=底) を下段 path[0..9] と、それを鏡映した上段 path[19..10] に表示
+            const uint8_t top_bottom_index = 10; // 上段の底 (path[10]=LED 20)
+            const uint8_t bottom_bottom_index = 9; // 下段の底 (path[9]=LED 10)
+
+            // 1. 表示設定 (毎回実行)
+            // anim_dir: 0=落下/バウンド中, 7=Blink1ON, 8=Blink1OFF, 9=Blink2ON, 10=Blink2OFF, 11=Pause
+            if (s->anim_dir == 0) { // 移動中
+                uint8_t height_index = physics_index(&s->particles[0]);
+                leds[0] = path[19 - height_index];
+                leds[1] = path[height_index];
+                current_led_count = 2;
+            } else if (s->anim_dir == 7 || s->anim_dir == 9) { // Blink ON
+                leds[0] = path[top_bottom_index];
+                leds[1] = path[bottom_bottom_index];
+                current_led_count = 2;
+            } // Blink OFF / Pause は current_led_count = 0 のまま
+
+            // 2. 時間経過チェックと状態更新
+            if (s->anim_dir == 0) {
+                // 固定tickで物理を進め、バウンドが収まったら点滅へ
+                while ((current_time - s->last_anim_time) >= PHYSICS_TICK_MS) {
+                    s->last_anim_time += PHYSICS_TICK_MS;
+                    if (physics_step(&phys_bounce, s->particles)) {
+                        s->anim_dir = 7;
+                        break;
+                    }
+                }
+            } else {
+                uint32_t required_interval_c5 = (s->anim_dir == 11) ? pause_ms : blink_ms;
+                if ((current_time - s->last_anim_time) >= required_interval_c5) {
+                    if (s->anim_dir == 11) {
+                        physics_init(&s->particles[0], 0, 0); // 頂点から再び落下
+                        s->anim_dir = 0;
+                    } else {
+                        s->anim_dir++;
+                    }
+                    s->last_anim_time = current_time;
+                }
+            }
+        }
+            break; // case 5 の終了
+
+        case 6: // 振り子 (物理エンジン版)
+        {
+            // 1. 表示設定 (毎回実行)
+            // 下半分 (path[0..9]) と上半分 (path[10..19]) を同じ位置で振る
+            uint8_t swing_index = physics_index(&s->particles[0]);
+            leds[0] = path[swing_index];
+            leds[1] = path[10 + swing_index];
+            current_led_count = 2;
+
+            // 2. 時間経過チェックと状態更新
+            while ((current_time - s->last_anim_time) >= PHYSICS_TICK_MS) {
+                s->last_anim_time += PHYSICS_TICK_MS;
+                physics_step(&phys_pendulum, s->particles);
+            }
+        }
+            break; // case 6 の終了
+
+        case 7: // スパークル (点滅版)
+        {
+            // --- アニメーション設定 ---
+            const uint32_t SPARKLE_ON_MS = 50;  // 点灯している時間
+            const uint32_t SPARKLE_OFF_MS = 80; // 消灯している時間
+            uint32_t required_interval_c7;
+            
+            // 1. 状態に応じたインターバルとLED表示設定
+            if (s->anim_dir == 0) {
+                // --- 点灯中の処理 ---
+                required_interval_c7 = SPARKLE_ON_MS;
+                
+                // 表示設定 (モード切替時 or 消灯->点灯時に生成されたLEDを表示)
+                current_led_count = 3;
+                leds[0] = s->sparkle_leds[0];
+                leds[1] = s->sparkle_leds[1];
+                leds[2] = s->sparkle_leds[2];
+
+            } else {
+                // --- 消灯中の処理 ---
+                required_interval_c7 = SPARKLE_OFF_MS;
+                
+                // 表示設定 (消灯)
+                current_led_count = 0;
+            }
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval_c7) {
+                s->last_anim_time = current_time;
+                
+                if (s->anim_dir == 0) {
+                    // 点灯 -> 消灯 へ
+                    s->anim_dir = 1;
+                } else {
+                    // 消灯 -> 点灯 へ
+                    s->anim_dir = 0;
+                    
+                    // ★ 次に点灯するLEDをここでランダムに生成 ★
+                    s->sparkle_leds[0] = path[rand() % 20];
+                    s->sparkle_leds[1] = path[rand() % 20];
+                    s->sparkle_leds[2] = path[rand() % 20];
+                }
+            }
+        }
+            break; // case 7 の終了
+
+        case 8: // コメット (3 LED)
+        {
+            // 彗星の速度 (ms)
+            uint32_t required_interval_c8 = 50;
+            
+            // 1. 表示設定 (毎回実行)
+            current_led_count = 3;
+            if (s->anim_index < 20) { // 範囲チェック (念のため)
+                // (s->anim_index - 1 + 20) % 20 は、アンダーフローを防ぐための計算
+                uint8_t index_head = s->anim_index;
+                uint8_t index_tail1 = (s->anim_index - 1 + 20) % 20;
+                uint8_t index_tail2 = (s->anim_index - 2 + 20) % 20;
+                
+                leds[0] = path[index_head];
+                leds[1] = path[index_tail1];
+                leds[2] = path[index_tail2];
+            }
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval_c8) {
+                s->last_anim_time = current_time;
+                
+                s->anim_index++;
+                if (s->anim_index >= 20) s->anim_index = 0;
+            }
+        }
+            break; // case 8 の終了
+
+        case 9: // 5個ずつのグループ点灯
+        {
+            // 1000msごとに、点灯するグループを変える
+            uint32_t required_interval_c9 = 500;
+            
+            // s->anim_index を 0, 1, 2, 3 のグループ番号として使用
+
+            // 1. 表示設定 (毎回実行)
+            current_led_count = 5;
+            
+            // s->anim_index (0-3) に応じて、path配列の開始オフセットを計算 (0, 5, 10, 15)
+            uint8_t start_index = s->anim_index * 5;
+            
+            // leds 配列を埋める (5個)
+            for (uint8_t i = 0; i < 5; i++) {
+                leds[i] = path[start_index + i];
+            }
+
+            // 2. 時間経過チェックと状態更新
+            if((current_time - s->last_anim_time) >= required_interval_c9) {
+                s->last_anim_time = current_time;
+                
+                s->anim_index++;
+                if (s->anim_index >= 4) { // グループは 0, 1, 2, 3 の 4つ
+                    s->anim_index = 0; // 4番目のグループが点灯したらリセット
+                }
+            }
+        }
+            break; // case 9 の終了
+
+        case 10: // 軌道 (逆向きに周回する2つの彗星)
+        case 11: // 衝突 (壁と互いに跳ね返る2つの玉、尾付きの方が粒子0)
+        {
+            const PhysicsParams_t* params = (anim_mode == 10) ? &phys_orbit : &phys_collide;
+
+            // 1. 表示設定 (毎回実行)
+            // 各粒子の位置と、その進行方向と逆側に尾を1つ表示する
+            // 周回 (wrap) なら尾は 0 と 19 の間も回り込み、壁がある場合は lo..hi の内側に留める
+            const uint8_t lo_index = params->lo >> 16;
+            const uint8_t hi_index = params->wrap ? 19 : (params->hi >> 16);
+            for (uint8_t i = 0; i < params->count; i++) {
+                uint8_t head = physics_index(&s->particles[i]);
+                uint8_t tail = head;
+                if (s->particles[i].vel >= 0) {
+                    if (head > lo_index) tail = head - 1;
+                    else if (params->wrap) tail = hi_index;
+                } else {
+                    if (head < hi_index) tail = head + 1;
+                    else if (params->wrap) tail = lo_index;
+                }
+                current_led_count = leds_add_unique(leds, current_led_count, path[head]);
+                if (anim_mode == 10 || i == 0) current_led_count = leds_add_unique(leds, current_led_count, path[tail]);
+            }
+
+            // 2. 時間経過チェックと状態更新
+            while ((current_time - s->last_anim_time) >= PHYSICS_TICK_MS) {
+                s->last_anim_time += PHYSICS_TICK_MS;
+                physics_step(params, s->particles);
+            }
+        }
+            break; // case 10, 11 の終了
+
+
+        default: // 想定外のモードは消灯
+            current_led_count = 0;
+            break;
+    } // switch(anim_mode) の終了
+
+    return current_led_count;
+}
+
+/**
+ * @brief LED番号から path 配列上のインデックス (0-19) を求める (path の逆引き)
+ */
+uint8_t path_position(uint8_t led_num)
+{
+    return (led_num <= 10) ? (led_num - 1) : (30 - led_num);
+}
+
+/**
+ * @brief ディゾルブで path 上の各位置を新モードに置き換える順番 (0-19) をランダムに並べる
+ * @note Fisher-Yates シャッフル。ボタン押下ごとに1回だけ呼び、遷移中は表を引くだけにする。
+ */
+void dissolve_shuffle(uint8_t* rank)
+{
+    for (uint8_t i = 0; i < 20; i++) rank[i] = i;
+    for (uint8_t i = 19; i > 0; i--) {
+        uint8_t j = rand() % (i + 1);
+        uint8_t tmp = rank[i];
+        rank[i] = rank[j];
+        rank[j] = tmp;
+    }
+}
+
+/**
+ * @brief 遷移で LED が新モードに置き換わる順番 (0-19) を返す (範囲外のLED番号は 20)
+ */
+uint8_t transition_rank(uint8_t type, uint8_t led_num, const uint8_t* dissolve_rank)
+{
+    uint8_t pos = path_position(led_num);
+    if (pos >= 20) return 20;
+    return (type == TRANSITION_DISSOLVE) ? dissolve_rank[pos] : pos;
+}
+
+/*********************************************************************
+ * @fn      transition_mix
+ * @brief   遷移中の旧モード/新モードのフレームを合成します。
+ * @param   type - 遷移の種類 (TransitionType_t)。
+ * @param   progress - 遷移の進み具合 (0-20, path上で新モードに置き換わったLED数に相当)。
+ * @param   elapsed_ms - 遷移開始からの経過時間 (クロスフェードのデューティ計算用)。
+ * @param   dissolve_rank - ディゾルブで各位置が置き換わる順番 (dissolve_shuffle で生成、20要素)。
+ * @param   in_leds, in_count - 新モードのフレーム。
+ * @param   out_leds, out_count - 旧モードのフレーム。
+ * @param   leds - 合成結果の書き込み先 (5要素、呼び出し側で0クリア済み)。
+ * @return  点灯するLEDの数 (0-5)。
+ */
+uint8_t transition_mix(uint8_t type, uint8_t progress, uint32_t elapsed_ms, const uint8_t* dissolve_rank,
+                       const uint8_t* in_leds, uint8_t in_count,
+                       const uint8_t* out_leds, uint8_t out_count, uint8_t* leds)
+{
+    uint8_t count = 0;
+
+    if (type == TRANSITION_CROSSFADE) {
+        // ダイナミック点灯は1フレームに最大5個までしか点灯できないため、
+        // 2つのフレームを TRANSITION_FADE_PERIOD_MS 周期で時分割し、
+        // 新モードを表示する割合 (デューティ) を progress に比例して増やす
+        // (周期内の位置 / 周期 < progress / 20 を、定数の乗算だけで比較する)
+        uint32_t phase = elapsed_ms & (TRANSITION_FADE_PERIOD_MS - 1);
+        const uint8_t* src = (phase * 20 < (uint32_t)progress * TRANSITION_FADE_PERIOD_MS) ? in_leds : out_leds;
+        uint8_t src_count = (src == in_leds) ? in_count : out_count;
+        for (uint8_t i = 0; i < src_count && i < 5; i++) {
+            leds[count++] = src[i];
+        }
+        return count;
+    }
+
+    // ワイプ: path上の位置が progress 未満のLEDは新モード、それ以降は旧モードを表示
+    // ディゾルブ: 押下ごとにシャッフルした dissolve_rank の順に置き換える
+    uint8_t in_sel[5], out_sel[5];
+    uint8_t in_n = 0, out_n = 0;
+    for (uint8_t i = 0; i < in_count && in_n < 5; i++) {
+        if (transition_rank(type, in_leds[i], dissolve_rank) < progress) in_sel[in_n++] = in_leds[i];
+    }
+    for (uint8_t i = 0; i < out_count && out_n < 5; i++) {
+        if (transition_rank(type, out_leds[i], dissolve_rank) >= progress) out_sel[out_n++] = out_leds[i];
+    }
+
+    // ダイナミック点灯は1フレームに最大5個まで。新旧合わせて5個を超える場合は
+    // 枠を progress に比例して分け (旧モード側が消えて暗転したように見えないように)、
+    // 片方が枠を使い切らなければ残りをもう片方に回す
+    uint8_t in_slots = in_n;
+    uint8_t out_slots = out_n;
+    if (in_n + out_n > 5) {
+        in_slots = progress >> 2; // progress * 5 / 20
+        if (in_slots > in_n) in_slots = in_n;
+        if (in_slots < 5 - out_n) in_slots = 5 - out_n;
+        out_slots = 5 - in_slots;
+    }
+    for (uint8_t i = 0; i < in_slots; i++) leds[count++] = in_sel[i];
+    for (uint8_t i = 0; i < out_slots; i++) leds[count++] = out_sel[i];
+    return count;
+}
+
+/**
+ * @brief SysTickカウンタ値 start_cnt からの経過サイクル数を返す (1ms未満の計測用)
+ * @note SysTickはHCLK(48MHz)でCMPまでカウントアップし0に戻るため、1回の折り返しまで補正します。
+ */
+uint32_t systick_cycles_since(uint32_t start_cnt)
+{
+    uint32_t now_cnt = SysTick->CNT;
+    if (now_cnt >= start_cnt) return now_cnt - start_cnt;
+    return now_cnt + (SysTick->CMP + 1) - start_cnt;
+}
+
+/**
+ * @brief 2つのアニメーション状態が (last_anim_time からの経過時間も含めて) 同じか調べる
+ */
+uint8_t anim_state_equal(const AnimState_t* a, uint32_t time_a, const AnimState_t* b, uint32_t time_b)
+{
+    return (time_a - a->last_anim_time) == (time_b - b->last_anim_time)
+        && a->anim_index == b->anim_index
+        && a->anim_step == b->anim_step
+        && a->anim_dir == b->anim_dir
+        && a->particles[0].pos == b->particles[0].pos && a->particles[0].vel == b->particles[0].vel
+        && a->particles[1].pos == b->particles[1].pos && a->particles[1].vel == b->particles[1].vel;
+}
+
+/**
+ * @brief タイムラインの展開を始める (実際の模擬実行は timeline_build_step で少しずつ行う)
+ * @note s は start_time の直前までを描画し終えた状態。展開中も s 自体はCPUでの描画に使い続けてよい。
+ */
+void timeline_build_begin(TimelineBuilder_t* b, uint8_t anim_mode, const AnimState_t* s, uint32_t start_time)
+{
+    b->start = *s;
+    b->sim = *s;
+    b->start_time = start_time;
+    b->elapsed_ms = 0;
+    b->ticks_per_ms = SCAN_TICKS_PER_MS; // 割り算は展開ごとに1回だけ
+    b->anim_mode = anim_mode;
+    timeline_length = 0;
+
+    // スパークルは rand() を使うため周期を持たない
+    b->state = (anim_mode == 7) ? TIMELINE_BUILD_FAILED : TIMELINE_BUILD_RUNNING;
+}
+
+/*********************************************************************
+ * @fn      timeline_build_step
+ * @brief   anim_update を最大 max_ms 回 (1msずつ) 模擬実行し、状態が展開開始時に戻るまでの
+ *          1周期分のフレームを timeline にランレングスで追記します。
+ * @note    anim_update 自体を使って展開するため、再生結果はCPUでの描画と同じフレーム列になります。
+ *          1回の呼び出しを短く区切り、展開中もメインループがCPUで描画を続けられるようにします。
+ *          周期が TIMELINE_MAX_SEARCH_MS より長い/フレーム数が多すぎるモードは展開しません。
+ * @param   b - 展開中の状態 (timeline_build_begin で初期化)。終わると b->state が DONE か FAILED になる。
+ * @param   max_ms - この呼び出しで模擬実行する最大時間 (ms)。
+ * @return  なし
+ */
+void timeline_build_step(TimelineBuilder_t* b, uint16_t max_ms)
+{
+    for (uint16_t n = 0; n < max_ms && b->state == TIMELINE_BUILD_RUNNING; n++) {
+        uint32_t t = b->start_time + b->elapsed_ms;
+        uint8_t frame[5] = {0};
+        uint8_t count = anim_update(b->anim_mode, &b->sim, t, frame);
+        b->elapsed_ms++;
+
+        // 直前と同じフレームなら表示時間を延ばし、違えば新しいエントリを追加
+        uint8_t length = timeline_length;
+        volatile TimelineEntry_t* last = (length > 0) ? &timeline[length - 1] : NULL;
+        if (last != NULL && last->count == count && last->ticks <= 0xFFFF - b->ticks_per_ms
+            && last->leds[0] == frame[0] && last->leds[1] == frame[1] && last->leds[2] == frame[2]
+            && last->leds[3] == frame[3] && last->leds[4] == frame[4]) {
+            last->ticks += b->ticks_per_ms;
+        } else if (length >= TIMELINE_MAX_ENTRIES) {
+            b->state = TIMELINE_BUILD_FAILED;
+            break;
+        } else {
+            for (uint8_t i = 0; i < 5; i++) timeline[length].leds[i] = frame[i];
+            timeline[length].count = count;
+            timeline[length].ticks = b->ticks_per_ms;
+            timeline_length = length + 1;
+        }
+
+        // 次の時刻の状態が展開開始時と同じになったら1周期
+        if (anim_state_equal(&b->sim, t + 1, &b->start, b->start_time)) {
+            timeline_period_ms = b->elapsed_ms;
+            b->state = TIMELINE_BUILD_DONE;
+        } else if (b->elapsed_ms >= TIMELINE_MAX_SEARCH_MS) {
+            b->state = TIMELINE_BUILD_FAILED;
+        }
+    }
+}
+
+/**
+ * @brief 展開し終えたタイムラインを、時刻 play_time に当たる周期内の位置から TIM1割り込みに再生させる
+ * @note 展開中もCPUで描画を続けていたため、展開開始からの経過時間を周期で割った余りの位置から始める。
+ *       経過時間は数周期以内なので、余りは割り算ではなく引き算で求める。
+ */
+void timeline_play(const TimelineBuilder_t* b, uint32_t play_time)
+{
+    uint32_t phase_ms = play_time - b->start_time;
+    while (phase_ms >= timeline_period_ms) phase_ms -= timeline_period_ms;
+
+    // 周期の先頭から phase_ms 分のtickを、表示中になるフレームの途中まで読み飛ばす
+    uint32_t skip = phase_ms * b->ticks_per_ms;
+    uint8_t pos = 0;
+    while (skip >= timeline[pos].ticks) {
+        skip -= timeline[pos].ticks;
+        pos++;
+    }
+
+    timeline_pos = pos;
+    timeline_now = pos;
+    timeline_skip_ticks = skip;
+    timeline_ticks_left = 0;
+    timeline_start = play_time;
+    timeline_output = 1;
+    timeline_active = 1;
+}
+
 // --- タイマー割り込みハンドラ ---
 
 /**
@@ -161,6 +1009,26 @@ void TIM1_UP_IRQHandler(void)
 {
     if(TIM_GetITStatus(TIM1, TIM_IT_Update) == SET)
     {
+        // --- タイムライン再生: 表示中のフレームの tick を使い切ったら次のフレームへ ---
+        // (再生開始時刻 timeline_start になるまでは、メインループが描画したフレームを表示したまま)
+        // 遷移中 (timeline_output = 0) も位置は進め、メインループが timeline_now を旧モードとして読む
+        if (timeline_active && (int32_t)(g_systick_ms - timeline_start) >= 0) {
+            if (timeline_ticks_left == 0) {
+                volatile TimelineEntry_t* entry = &timeline[timeline_pos];
+                if (timeline_output) {
+                    for (uint8_t i = 0; i < 5; i++) leds_to_display[i] = entry->leds[i];
+                    LED_volume = (entry->count == 0) ? 1 : entry->count;
+                }
+                timeline_now = timeline_pos;
+                timeline_ticks_left = entry->ticks - timeline_skip_ticks;
+                timeline_skip_ticks = 0;
+                timeline_pos++;
+                if (timeline_pos >= timeline_length) timeline_pos = 0;
+            }
+            timeline_ticks_left--;
+            if (timeline_ticks_left == 0) timeline_now = timeline_pos; // 次のtickからは次のフレーム
+        }
+
         uint8_t led_num = 0;
         // LED_volume は 1 から 5 の範囲と想定
         if (LED_volume > 0 && dynamic_drive_counter < LED_volume && dynamic_drive_counter < 5) {
@@ -242,9 +1110,9 @@ void BoardInit(void){
     SysTick->CNT = 0;
     SysTick->CTLR = 0xF;
 
-    // TIM1をダイナミック点灯用に設定 (例: 約1ms周期 = 1kHz)
-    // 24MHz / (24 * 1000) = 1kHz
-    TIM1_INT_Init(500 - 1, 24 - 1);    //500
+    // TIM1をダイナミック点灯用に設定 (0.25ms周期 = 4kHz)
+    // 48MHz / 24 / 500 = 4kHz (タイムライン再生の SCAN_TICKS_PER_MS もこの値から導出)
+    TIM1_INT_Init(TIM1_PERIOD - 1, TIM1_PRESCALER - 1);
     TIM_Cmd( TIM1, ENABLE );
 }
 
@@ -261,22 +1129,27 @@ int main(void)
     const uint8_t SWITCH_SAMPLING_MS = 5; // ms
 
     // --- 時間管理とアニメーション状態の変数 ---
-    const uint8_t MODE_VARS = 10; // ★ モード数 0-5 (計6種類) ★
-    uint32_t last_anim_time = 0; // アニメーションステップ更新用
-    uint32_t last_sample_time = 0; // スイッチサPLING用
-
-    // 各アニメーションで使用する状態変数 (モード切替時にリセット)
-    uint8_t anim_index = 0; // path配列のインデックス (0-19) や他の用途
-    uint8_t anim_index_top = 10; // case 6 用
-    uint8_t anim_index_bottom = 0; // case 6 用
-    uint8_t anim_step = 1;  // case 0, 2 で使用
-    uint8_t anim_dir = 0;   // アニメーションの方向/状態管理用
-
-    uint8_t sparkle_leds[3] = {0}; // ★ case 7 (スパークル) 用のLED配列 ★
-
-    // 物理的な反時計回りのLED番号の並び順
-    const uint8_t path[20] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,  // index 0-9
-                              20,19,18,17,16,15,14,13,12, 11}; // index 10-19
+    const uint8_t MODE_VARS = 12; // ★ モード数 0-11 (計12種類) ★
+    uint32_t last_sample_time = 0; // スイッチサンプリング用
+
+    // anim_states[anim_cur] が現在のモード、もう一方が遷移中の旧モードの状態
+    AnimState_t anim_states[2];
+    uint8_t anim_cur = 0;
+    anim_reset(mode, &anim_states[anim_cur], g_systick_ms);
+
+    // --- モード遷移の状態 ---
+    uint8_t transition_active = 0;
+    uint8_t transition_type = TRANSITION_TYPES - 1; // 最初の押下でワイプになるように
+    uint8_t dissolve_rank[20] = {0}; // ディゾルブの置き換え順 (押下ごとにシャッフル)
+    uint8_t prev_mode = 0;
+    uint32_t transition_start = 0;
+    uint32_t transition_step_time = 0; // 最後に progress を進めた時刻
+    uint8_t transition_progress = 0;   // 0-20 (20で遷移完了)
+    uint8_t transition_out = TRANSITION_OUT_ANIM;
+    uint8_t transition_hold[5] = {0}; // 遷移中に再び押されたとき、次の遷移の旧モードとして残すフレーム
+    uint8_t transition_hold_count = 0;
+
+    TimelineBuilder_t timeline_builder = { .state = TIMELINE_BUILD_IDLE };
 
     // mode = 6; // デバッグ用
 
@@ -296,412 +1169,111 @@ int main(void)
 
         if (switch_on_counter >= SWITCH_THRESHOLD/SWITCH_SAMPLING_MS) {
             if (switch_state == 1) { // 押された瞬間のみ
+                // 次の遷移の旧モードのフレームをどこから取るか決める
+                if (transition_active) {
+                    // 遷移中に押された場合、新旧2つの状態を持ち続けることはできない (3つ目の領域がない) ため、
+                    // 表示中の合成フレームを静止画として残し、そこから次の遷移を始める
+                    // (旧モード側を消して新モードだけから始めると、押した瞬間に表示の一部が消えてしまう)
+                    timeline_active = 0; // その遷移の旧モードのタイムラインはもう使わない
+                    transition_out = TRANSITION_OUT_HOLD;
+                } else if (timeline_active) {
+                    // タイムライン再生中なら表示だけ止めて位置は進め続け、遷移中の旧モードのフレームとして使う
+                    // (再生中は状態変数が止まっているため、anim_update では旧モードを続けられない)
+                    timeline_output = 0;
+                    transition_out = TRANSITION_OUT_TIMELINE;
+                } else {
+                    transition_out = TRANSITION_OUT_ANIM;
+                }
+                timeline_builder.state = TIMELINE_BUILD_IDLE; // 新モードは遷移が終わってから展開する
+
+                prev_mode = mode;
                 mode++;
                 if (mode >= MODE_VARS) mode = 0;
 
-                // --- ★★★ モード切り替え時の状態リセット (単純化) ★★★ ---
-                anim_index = 0;        // デフォルト開始インデックス
-                anim_step = 1;         // デフォルト開始ステップ
-                anim_dir = 0;          // デフォルト方向/状態
-                anim_index_top = 19;   // case 6 用デフォルト
-                anim_index_bottom = 0; // case 6 用デフォルト
-
-                if (mode == 5) { // case 5 (同時落下バウンド 19->10, 0->9) - case番号注意
-                    anim_index_top = 19;
-                    anim_index_bottom = 0;
-                    anim_dir = 0;
-                }
-                else if (mode == 6) { // ★ case 6 (振り子) 用の初期値を追加 ★
-                    // anim_index_top = 19;    // 上半分の開始位置 (path[19] = LED 11)
-                    anim_index_top = 10;
-                    anim_index_bottom = 0;  // 下半分の開始位置 (path[0] = LED 1)
-                    anim_dir = 0;           // 0 = 増加方向 (0->9)
-                }
-                else if (mode == 7) { // ★ case 7 (スパークル) 用の初期化 ★
-                    // 最初のフレームを生成しておく
-                    sparkle_leds[0] = path[rand() % 20];
-                    sparkle_leds[1] = path[rand() % 20];
-                    sparkle_leds[2] = path[rand() % 20];
-                }
-                else if (mode == 8) { // ★ case 8 (コメット) 用 ★
-                    anim_index = 0; // デフォルトだが明示
-                }
-                // --- ★★★ ここまでリセット処理 ★★★ ---
+                // 現在のモードの状態を残したまま、もう一方の領域を新モード用にリセット
+                anim_cur ^= 1;
+                anim_reset(mode, &anim_states[anim_cur], current_time);
+
+                transition_type++;
+                if (transition_type >= TRANSITION_TYPES) transition_type = 0;
+                dissolve_shuffle(dissolve_rank);
+                transition_start = current_time;
+                transition_step_time = current_time;
+                transition_progress = 0;
+                transition_active = 1;
 
                 switch_state = 0; // 押されている状態に
-                last_anim_time = current_time; // アニメーション時間もリセット
             }
         } else {
             switch_state = 1;
         }
         // --- ここまでスイッチ処理 ---
 
-        uint8_t current_led_count = 0; // このループで TIM ハンドラに渡すLED数
-
-        memset((void*)leds_to_display, 0, sizeof(leds_to_display));
-
-        switch(mode)
-        {
-            case 0: // 向かい合わせ
-            {
-                uint32_t required_interval = 50;
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 2;
-                uint8_t current_led_num = (anim_step >= 1 && anim_step <= 10) ? anim_step : 1;
-                leds_to_display[0] = current_led_num;
-                leds_to_display[1] = current_led_num + 10;
-
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval) {
-                    anim_step++;
-                    if(anim_step > 10) anim_step = 1;
-                    last_anim_time = current_time;
-                }
-            }
-                break;
-
-            case 1: // path配列を1周 (単一LED)
-            {
-                uint32_t required_interval = 20;
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 1;
-                if (anim_index < 20) { leds_to_display[0] = path[anim_index]; }
+        if (timeline_active && timeline_output) {
+            // 表示はTIM1割り込みが進めるので、次の割り込みまで眠ってスイッチ処理だけ続ける
+            __WFI();
+            continue;
+        }
 
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval) {
-                    anim_index++;
-                    if(anim_index >= 20) anim_index = 0;
-                    last_anim_time = current_time;
-                }
+        uint32_t frame_start_cnt = SysTick->CNT;
+        uint8_t frame_in[5] = {0};
+        uint8_t current_led_count = anim_update(mode, &anim_states[anim_cur], current_time, frame_in);
+        const uint8_t* frame = frame_in;
+
+        // --- モード遷移: 旧モードも動かし続け、2つのフレームを合成する ---
+        uint8_t frame_mixed[5] = {0};
+        uint8_t in_transition = transition_active;
+        if (transition_active) {
+            // progress は割り算を使わず、TRANSITION_STEP_MS ごとに1つ進める
+            while ((current_time - transition_step_time) >= TRANSITION_STEP_MS) {
+                transition_step_time += TRANSITION_STEP_MS;
+                transition_progress++;
             }
-                break;
-
-            case 2: // バウンス (1-5往復、4LED)
-            {
-                uint32_t required_interval_c2;
-                if (anim_dir == 2) { required_interval_c2 = 1000; } else { required_interval_c2 = 75; }
-
-                // 1. 表示設定 (毎回実行)
-                if (anim_step != 0 && anim_dir != 2) { // Pause中でなければ
-                    leds_to_display[0] = anim_step; // anim_step は 1-5
-                    leds_to_display[1] = 11 - anim_step;
-                    leds_to_display[2] = 10 + anim_step;
-                    leds_to_display[3] = 21 - anim_step;
-                    current_led_count = 4;
+            if (transition_progress >= 20) {
+                transition_active = 0; // 遷移完了
+                timeline_active = 0;   // 旧モードのタイムラインも不要になる
+            } else {
+                uint8_t frame_out[5] = {0};
+                uint8_t out_count;
+                if (transition_out == TRANSITION_OUT_TIMELINE) {
+                    volatile TimelineEntry_t* entry = &timeline[timeline_now];
+                    for (uint8_t i = 0; i < 5; i++) frame_out[i] = entry->leds[i];
+                    out_count = entry->count;
+                } else if (transition_out == TRANSITION_OUT_HOLD) {
+                    memcpy(frame_out, transition_hold, sizeof(frame_out));
+                    out_count = transition_hold_count;
                 } else {
-                    current_led_count = 0;
-                }
-
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval_c2) {
-                    if (anim_dir == 0) { anim_step++; if (anim_step > 5) { anim_step = 4; anim_dir = 1; } }
-                    else if (anim_dir == 1) { anim_step--; if (anim_step < 1) { anim_step = 0; anim_dir = 2; } }
-                    else { anim_step = 1; anim_dir = 0; }
-                    last_anim_time = current_time;
-                }
-            }
-                break;
-
-            case 3: // path配列を1周 (3LED等間隔)
-            {
-                uint32_t required_interval = 50;
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 3;
-                if (anim_index < 20) {
-                    uint8_t index1 = anim_index;
-                    uint8_t index2 = (anim_index + 7) % 20;
-                    uint8_t index3 = (anim_index + 14) % 20;
-                    leds_to_display[0] = path[index1];
-                    leds_to_display[1] = path[index2];
-                    leds_to_display[2] = path[index3];
-                    leds_to_display[3] = 0; //明示しないとゴーストが出る
-                }
-
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval) {
-                    anim_index++;
-                    if (anim_index >= 20) anim_index = 0;
-                    last_anim_time = current_time;
-                }
-            }
-                break;
-
-            
-            case 4: // 2段階加速アニメーション
-            {
-                uint32_t required_interval_c4;
-                const uint8_t segment_steps = 10;
-                const uint16_t start_duration_c4 = 100;
-                const uint16_t end_duration_c4 = 5;
-
-                // 1. 表示設定 (毎回実行)
-                if ((anim_dir == 0 || anim_dir == 2) && anim_index < 20) { // Moving
-                    leds_to_display[0] = path[anim_index];
-                    current_led_count = 1;
-                } else { // Paused
-                    current_led_count = 0;
-                }
-
-                // 2. 時間経過チェックと状態更新
-                switch(anim_dir) {
-                    case 0: required_interval_c4 = calculate_duration(start_duration_c4, end_duration_c4, segment_steps, anim_index); break;
-                    case 2: required_interval_c4 = calculate_duration(start_duration_c4, end_duration_c4, segment_steps, anim_index - 10); break;
-                    case 1: case 3: default: required_interval_c4 = 1000; break;
-                }
-
-                if((current_time - last_anim_time) >= required_interval_c4) {
-                    switch(anim_dir) {
-                        case 0: if (anim_index == (segment_steps - 1)) { anim_dir = 1; } else { anim_index++; } break;
-                        case 1: anim_index = 10; anim_dir = 2; break;
-                        case 2: if (anim_index == (segment_steps * 2 - 1)) { anim_dir = 3; } else { anim_index++; } break;
-                        case 3: default: anim_index = 0; anim_dir = 0; break;
-                    }
-                    last_anim_time = current_time;
-                }
-            }
-                break; // case 4 の終了
-
-            case 5: // ★ 上下同時落下?バウンド ★
-            {
-                uint32_t required_interval_c5 = 100; // 変数名を _c5 に統一
-                uint8_t current_segment_step = 0;
-                uint8_t total_segment_steps = 1;
-
-                // アニメーションパラメータ
-                const uint16_t fall_start_ms = 100; // 落下速度 (必要に応じて調整)
-                const uint16_t fall_end_ms   = 20;
-                const uint16_t blink_ms      = 50;
-                const uint16_t pause_ms      = 1000;
-
-                // バウンドの頂点?底インデックス
-                const uint8_t top_bottom_index = 10; // 上段の底 (path[10]=LED 20)
-                const uint8_t bottom_bottom_index = 9; // 下段の底 (path[9]=LED 10)
-                // バウンドの高さ (底からのオフセット)
-                const uint8_t bounce1_offset = 4;
-                const uint8_t bounce2_offset = 2;
-                const uint8_t bounce3_offset = 1;
-
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 0;
-                // anim_dir: 0=落下, 1=B1↑, 2=B1↓, ..., 7=Blink1ON, 8=Blink1OFF, 9=Blink2ON, 10=Blink2OFF, 11=Pause
-                if (anim_dir <= 6) { // 移動中
-                    if (anim_index_top >= top_bottom_index && anim_index_top < 20) { leds_to_display[current_led_count++] = path[anim_index_top]; }
-                    if (anim_index_bottom <= bottom_bottom_index && anim_index_bottom < 10) { leds_to_display[current_led_count++] = path[anim_index_bottom]; }
-                } else if (anim_dir == 7 || anim_dir == 9) { // Blink ON
-                    leds_to_display[0] = path[top_bottom_index];
-                    leds_to_display[1] = path[bottom_bottom_index];
-                    current_led_count = 2;
-                } // Blink OFF / Pause は current_led_count = 0 のまま
-
-                // 2. 時間経過チェックと状態更新
-                // 現在の状態に応じた時間間隔を計算 (下段の動きで代表させる)
-                switch(anim_dir) {
-                    case 0: total_segment_steps = 10; current_segment_step = anim_index_bottom; required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, total_segment_steps, current_segment_step); break;
-                    case 1: total_segment_steps = bounce1_offset + 1; current_segment_step = bottom_bottom_index - anim_index_bottom; required_interval_c5 = calculate_duration(fall_end_ms, fall_start_ms, total_segment_steps, current_segment_step); break;
-                    case 2: total_segment_steps = bounce1_offset + 1; current_segment_step = anim_index_bottom - (bottom_bottom_index - bounce1_offset); required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, total_segment_steps, current_segment_step); break;
-                    case 3: total_segment_steps = bounce2_offset + 1; current_segment_step = bottom_bottom_index - anim_index_bottom; required_interval_c5 = calculate_duration(fall_end_ms, fall_start_ms, total_segment_steps, current_segment_step); break;
-                    case 4: total_segment_steps = bounce2_offset + 1; current_segment_step = anim_index_bottom - (bottom_bottom_index - bounce2_offset); required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, total_segment_steps, current_segment_step); break;
-                    case 5: total_segment_steps = bounce3_offset + 1; current_segment_step = bottom_bottom_index - anim_index_bottom; required_interval_c5 = calculate_duration(fall_end_ms, fall_start_ms, total_segment_steps, current_segment_step); break;
-                    case 6: total_segment_steps = bounce3_offset + 1; current_segment_step = anim_index_bottom - (bottom_bottom_index - bounce3_offset); required_interval_c5 = calculate_duration(fall_start_ms, fall_end_ms, total_segment_steps, current_segment_step); break;
-                    case 7: case 8: case 9: case 10: required_interval_c5 = blink_ms; break;
-                    case 11: default: required_interval_c5 = pause_ms; break;
-                }
-
-                if((current_time - last_anim_time) >= required_interval_c5) {
-                    // 次の状態へ遷移 (上下同時に更新)
-                    switch(anim_dir) {
-                        case 0: if (anim_index_bottom == bottom_bottom_index) anim_dir = 1; else { anim_index_top--; anim_index_bottom++; } break;
-                        case 1: if (anim_index_bottom == (bottom_bottom_index - bounce1_offset)) anim_dir = 2; else { anim_index_top++; anim_index_bottom--; } break;
-                        case 2: if (anim_index_bottom == bottom_bottom_index) anim_dir = 3; else { anim_index_top--; anim_index_bottom++; } break;
-                        case 3: if (anim_index_bottom == (bottom_bottom_index - bounce2_offset)) anim_dir = 4; else { anim_index_top++; anim_index_bottom--; } break;
-                        case 4: if (anim_index_bottom == bottom_bottom_index) anim_dir = 5; else { anim_index_top--; anim_index_bottom++; } break;
-                        case 5: if (anim_index_bottom == (bottom_bottom_index - bounce3_offset)) anim_dir = 6; else { anim_index_top++; anim_index_bottom--; } break;
-                        case 6: if (anim_index_bottom == bottom_bottom_index) anim_dir = 7; else { anim_index_top--; anim_index_bottom++; } break;
-                        case 7: anim_dir = 8; break;
-                        case 8: anim_dir = 9; break;
-                        case 9: anim_dir = 10; break;
-                        case 10: anim_dir = 11; break;
-                        case 11: default: anim_index_top = 19; anim_index_bottom = 0; anim_dir = 0; break;
-                    }
-                    last_anim_time = current_time;
-                }
-            }
-                break; // case 5 の終了
-            
-            case 6: // 振り子 (イージング修正版)
-            {
-                uint32_t required_interval_c6;
-                uint8_t current_segment_step = 0;
-
-                // 振り子の端（最も遅い）と中央（最も速い）の持続時間
-                const uint16_t swing_slow_ms = 200;
-                const uint16_t swing_fast_ms = 10;
-
-                // 振り子の片道は10ステップ (0..9)
-                // その半分のステップ数 (0..4 の 5ステップ) で加速/減速が完了する
-                const uint8_t total_segment_steps = 5; // 0, 1, 2, 3, 4 の5段階
-
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 2;
-                if (anim_index_bottom < 10) { // 下半分 (0-9)
-                    leds_to_display[0] = path[anim_index_bottom];
-                }
-                if (anim_index_top >= 10 && anim_index_top < 20) { // 上半分 (10-19)
-                    leds_to_display[1] = path[anim_index_top];
+                    out_count = anim_update(prev_mode, &anim_states[anim_cur ^ 1], current_time, frame_out);
                 }
-
-                // 2. 時間経過チェックと状態更新
-                // anim_index_bottom (0..9) の位置に基づいて、
-                // 端(0)からの経過ステップ数 (0..4) を計算する
-                if (anim_index_bottom < 5) {
-                    // 加速フェーズ (0 -> 4)
-                    current_segment_step = anim_index_bottom; // 0, 1, 2, 3, 4
+                uint8_t in_count = current_led_count;
+                current_led_count = transition_mix(transition_type, transition_progress,
+                                                   current_time - transition_start, dissolve_rank,
+                                                   frame_in, in_count, frame_out, out_count, frame_mixed);
+                frame = frame_mixed;
+
+                // 遷移中に再び押されたときに残すフレームを更新する
+                // (クロスフェードは新旧を時分割で切り替えているため、表示の割合が大きい側のフレームを残す)
+                if (transition_type != TRANSITION_CROSSFADE) {
+                    memcpy(transition_hold, frame_mixed, sizeof(transition_hold));
+                    transition_hold_count = current_led_count;
+                } else if (transition_progress >= 10) {
+                    memcpy(transition_hold, frame_in, sizeof(transition_hold));
+                    transition_hold_count = in_count;
                 } else {
-                    // 減速フェーズ (5 -> 9)
-                    current_segment_step = 9 - anim_index_bottom; // 4, 3, 2, 1, 0
-                }
-                
-                // (端:slow, 中央:fast, ステップ数, 現在ステップ)
-                // これにより、持続時間は (100, 82, 65, 47, 30, 30, 47, 65, 82, 100) のように変化する
-                required_interval_c6 = calculate_duration(swing_slow_ms, swing_fast_ms, total_segment_steps, current_segment_step);
-
-
-                if((current_time - last_anim_time) >= required_interval_c6) {
-                    last_anim_time = current_time; // 時間を更新
-                    if (anim_dir == 0) { // 増加方向 (下: 0->9, 上: 10->19)
-                        if (anim_index_bottom >= 9) {
-                            anim_dir = 1; // 折り返し (次から減少)
-                            // 実際には9->8の更新は次のループ
-                            anim_index_bottom--;
-                            anim_index_top--; // ★ 変更 (++) -> (--)
-                        } else {
-                            anim_index_bottom++;
-                            anim_index_top++; // ★ 変更 (--) -> (++)
-                        }
-                    } else { // 減少方向 (下: 9->0, 上: 19->10)
-                        if (anim_index_bottom == 0) { // 0になったら
-                            anim_dir = 0; // 折り返し (次から増加)
-                            // 実際には0->1の更新は次のループ
-                            anim_index_bottom++;
-                            anim_index_top++; // ★ 変更 (--) -> (++)
-                        } else {
-                            anim_index_bottom--;
-                            anim_index_top--; // ★ 変更 (++) -> (--)
-                        }
-                    }
+                    memcpy(transition_hold, frame_out, sizeof(transition_hold));
+                    transition_hold_count = out_count;
                 }
             }
-                break; // case 6 の終了
-
-            case 7: // スパークル (点滅版)
-            {
-                // --- アニメーション設定 ---
-                const uint32_t SPARKLE_ON_MS = 50;  // 点灯している時間
-                const uint32_t SPARKLE_OFF_MS = 80; // 消灯している時間
-                uint32_t required_interval_c7;
-                
-                // 1. 状態に応じたインターバルとLED表示設定
-                if (anim_dir == 0) {
-                    // --- 点灯中の処理 ---
-                    required_interval_c7 = SPARKLE_ON_MS;
-                    
-                    // 表示設定 (モード切替時 or 消灯->点灯時に生成されたLEDを表示)
-                    current_led_count = 3;
-                    leds_to_display[0] = sparkle_leds[0];
-                    leds_to_display[1] = sparkle_leds[1];
-                    leds_to_display[2] = sparkle_leds[2];
-
-                } else {
-                    // --- 消灯中の処理 ---
-                    required_interval_c7 = SPARKLE_OFF_MS;
-                    
-                    // 表示設定 (消灯)
-                    current_led_count = 0;
-                }
-
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval_c7) {
-                    last_anim_time = current_time;
-                    
-                    if (anim_dir == 0) {
-                        // 点灯 -> 消灯 へ
-                        anim_dir = 1;
-                    } else {
-                        // 消灯 -> 点灯 へ
-                        anim_dir = 0;
-                        
-                        // ★ 次に点灯するLEDをここでランダムに生成 ★
-                        sparkle_leds[0] = path[rand() % 20];
-                        sparkle_leds[1] = path[rand() % 20];
-                        sparkle_leds[2] = path[rand() % 20];
-                    }
-                }
-            }
-                break; // case 7 の終了
-
-            case 8: // コメット (3 LED)
-            {
-                // 彗星の速度 (ms)
-                uint32_t required_interval_c8 = 50;
-                
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 3;
-                if (anim_index < 20) { // 範囲チェック (念のため)
-                    // (anim_index - 1 + 20) % 20 は、アンダーフローを防ぐための計算
-                    uint8_t index_head = anim_index;
-                    uint8_t index_tail1 = (anim_index - 1 + 20) % 20;
-                    uint8_t index_tail2 = (anim_index - 2 + 20) % 20;
-                    
-                    leds_to_display[0] = path[index_head];
-                    leds_to_display[1] = path[index_tail1];
-                    leds_to_display[2] = path[index_tail2];
-                }
-
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval_c8) {
-                    last_anim_time = current_time;
-                    
-                    anim_index++;
-                    if (anim_index >= 20) anim_index = 0;
-                }
-            }
-                break; // case 8 の終了
-
-            case 9: // 5個ずつのグループ点灯
-            {
-                // 1000msごとに、点灯するグループを変える
-                uint32_t required_interval_c9 = 500;
-                
-                // anim_index を 0, 1, 2, 3 のグループ番号として使用
-
-                // 1. 表示設定 (毎回実行)
-                current_led_count = 5;
-                
-                // anim_index (0-3) に応じて、path配列の開始オフセットを計算 (0, 5, 10, 15)
-                uint8_t start_index = anim_index * 5;
-                
-                // leds_to_display 配列を埋める (5個)
-                for (uint8_t i = 0; i < 5; i++) {
-                    leds_to_display[i] = path[start_index + i];
-                }
-
-                // 2. 時間経過チェックと状態更新
-                if((current_time - last_anim_time) >= required_interval_c9) {
-                    last_anim_time = current_time;
-                    
-                    anim_index++;
-                    if (anim_index >= 4) { // グループは 0, 1, 2, 3 の 4つ
-                        anim_index = 0; // 4番目のグループが点灯したらリセット
-                    }
-                }
-            }
-                break; // case 9 の終了
+        }
 
+        uint32_t frame_cycles = systick_cycles_since(frame_start_cnt);
+        if (in_transition) {
+            if (frame_cycles > g_transition_frame_cycles_max) g_transition_frame_cycles_max = frame_cycles;
+        } else {
+            if (frame_cycles > g_frame_cycles_max) g_frame_cycles_max = frame_cycles;
+        }
 
-            default: // 想定外のモードは消灯
-                current_led_count = 0;
-                break;
-        } // switch(mode) の終了
+        memcpy((void*)leds_to_display, frame, sizeof(leds_to_display));
 
         // TIMハンドラが参照するLED数を設定 (0の場合は最低1にする)
         // かつ、配列サイズ4を超えないように制限
@@ -709,5 +1281,24 @@ int main(void)
         // if (LED_volume > 4) LED_volume = 4; // 最大4個に制限
         if (LED_volume > 5) LED_volume = 5; // 最大4個に制限
 
+        // --- タイムライン再生: 遷移が終わったら1周期分を少しずつ展開し、できたらTIM1割り込みに任せる ---
+        // (モード開始直後の状態は二度と現れないため、このフレームを描画した後の状態から展開する)
+        if (!transition_active) {
+            if (timeline_builder.state == TIMELINE_BUILD_IDLE) {
+                timeline_build_begin(&timeline_builder, mode, &anim_states[anim_cur], current_time + 1);
+            } else if (timeline_builder.state == TIMELINE_BUILD_RUNNING) {
+                uint32_t step_start_cnt = SysTick->CNT;
+                timeline_build_step(&timeline_builder, TIMELINE_BUILD_STEP_MS);
+                uint32_t step_cycles = systick_cycles_since(step_start_cnt);
+                if (step_cycles > g_timeline_step_cycles_max) g_timeline_step_cycles_max = step_cycles;
+
+                if (timeline_builder.state == TIMELINE_BUILD_DONE) {
+                    uint32_t build_ms = current_time + 1 - timeline_builder.start_time;
+                    if (build_ms > g_timeline_build_ms_max) g_timeline_build_ms_max = build_ms;
+                    timeline_play(&timeline_builder, current_time + 1);
+                }
+            }
+        }
+
     } // while(1) の終了
 } // main の終了